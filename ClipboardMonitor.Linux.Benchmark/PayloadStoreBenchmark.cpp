@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "../ClipboardMonitor.Linux/PayloadStore.h"
+#include "../ClipboardMonitor.Linux/SearchIndex.h"
+#include "../ClipboardMonitor.Linux/lz77.h"
+
+// Benchmark of payload storage: compression ratio vs. CPU time on generated clipboard traces.
+// Each trace is stored, packed on the background thread, then fetched back and checked byte for byte.
+// LZ77 on its own (no near-duplicate deltas) is measured alongside for comparison.
+// A second pass times search over a 100k entry history and checks every result against a linear scan.
+// zlib is only used here, to PNG-encode the screenshot trace the way a real clipboard owner would.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -pthread ClipboardMonitor.Linux.Benchmark/PayloadStoreBenchmark.cpp ClipboardMonitor.Linux/PayloadStore.cpp ClipboardMonitor.Linux/SearchIndex.cpp -lz -o PayloadStoreBenchmark
+//   ./PayloadStoreBenchmark
+
+// Clipboard data types (as ClipboardMonitor.h)
+const int TEXT = 1;
+const int FILES = 2;
+const int IMAGE = 3;
+
+struct Capture {
+    int type;
+    std::string data;
+};
+
+using Trace = std::vector<Capture>;
+using Clock = std::chrono::steady_clock;
+
+// A document copied again after each small edit, with unrelated short snippets in between
+Trace editedDocumentTrace(std::mt19937& rng) {
+    const char* words[] = { "the ", "customer ", "reported ", "that ", "invoice ", "number ", "was ", "missing ",
+        "from ", "account ", "\n", "refund ", "ticket ", "escalated ", "to ", "billing " };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    std::string document;
+    for (int i = 0; i < 3000; ++i)
+        document += words[rng() % wordCount];
+
+    Trace trace;
+    for (int i = 0; i < 200; ++i) {
+        document.insert(rng() % document.size(), words[rng() % wordCount]);
+        if (rng() % 3 == 0)
+            document.erase(rng() % document.size(), 20);
+        trace.push_back({ TEXT, document });
+
+        if (i % 10 == 0) {
+            std::string snippet;
+            for (int j = 0; j < 10; ++j)
+                snippet += words[rng() % wordCount];
+            trace.push_back({ TEXT, snippet });
+            trace.push_back({ FILES, "file:///home/user/reports/report" + std::to_string(i) + ".pdf\r\n" });
+        }
+    }
+    return trace;
+}
+
+// 800x600 RGBA desktop: gradient background, flat windows and rows of text-like glyphs.
+// Each call changes a small region (a line being typed), as between consecutive screenshots.
+class Screen {
+public:
+    static const size_t Width = 800;
+    static const size_t Height = 600;
+
+    explicit Screen(std::mt19937& rng) : rng_(rng), pixels_(Width * Height * 4) {
+        for (size_t y = 0; y < Height; ++y) {
+            for (size_t x = 0; x < Width; ++x)
+                set(x, y, static_cast<uint8_t>(40 + y / 10), static_cast<uint8_t>(60 + x / 20), 120);
+        }
+
+        fill(100, 80, 600, 440, 245, 245, 245);
+        fill(100, 80, 600, 24, 60, 90, 160);
+        for (size_t line = 0; line < 20; ++line)
+            text(110, 120 + line * 18, 10 + rng_() % 60);
+    }
+
+    void typeLine(int k) {
+        size_t y = 120 + (k % 20) * 18;
+        fill(110, y, 580, 14, 245, 245, 245);
+        text(110, y, 10 + rng_() % 60);
+    }
+
+    const std::vector<uint8_t>& pixels() const { return pixels_; }
+
+private:
+    void set(size_t x, size_t y, uint8_t r, uint8_t g, uint8_t b) {
+        uint8_t* p = &pixels_[(y * Width + x) * 4];
+        p[0] = r; p[1] = g; p[2] = b; p[3] = 255;
+    }
+
+    void fill(size_t x0, size_t y0, size_t w, size_t h, uint8_t r, uint8_t g, uint8_t b) {
+        for (size_t y = y0; y < y0 + h; ++y) {
+            for (size_t x = x0; x < x0 + w; ++x)
+                set(x, y, r, g, b);
+        }
+    }
+
+    // Glyphs are random 6x10 dot patterns, one per character
+    void text(size_t x0, size_t y0, size_t characters) {
+        for (size_t c = 0; c < characters && x0 + c * 8 + 6 < 690; ++c) {
+            uint64_t glyph = (static_cast<uint64_t>(rng_()) << 32) | rng_();
+            for (size_t i = 0; i < 60; ++i) {
+                if (glyph >> i & 1)
+                    set(x0 + c * 8 + i % 6, y0 + i / 6, 30, 30, 30);
+            }
+        }
+    }
+
+    std::mt19937& rng_;
+    std::vector<uint8_t> pixels_;
+};
+
+void appendChunk(std::string& png, const char* type, const std::vector<uint8_t>& data) {
+    uint8_t length[4] = { static_cast<uint8_t>(data.size() >> 24), static_cast<uint8_t>(data.size() >> 16),
+        static_cast<uint8_t>(data.size() >> 8), static_cast<uint8_t>(data.size()) };
+    png.append(reinterpret_cast<const char*>(length), 4);
+
+    size_t start = png.size();
+    png.append(type, 4);
+    png.append(data.begin(), data.end());
+
+    uLong crc = crc32(0, reinterpret_cast<const Bytef*>(png.data() + start), static_cast<uInt>(png.size() - start));
+    uint8_t crcBytes[4] = { static_cast<uint8_t>(crc >> 24), static_cast<uint8_t>(crc >> 16),
+        static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc) };
+    png.append(reinterpret_cast<const char*>(crcBytes), 4);
+}
+
+// RGBA PNG with the Sub filter on every row and default zlib compression
+std::string encodePng(const std::vector<uint8_t>& pixels, size_t width, size_t height) {
+    std::vector<uint8_t> raw;
+    raw.reserve(height * (width * 4 + 1));
+    for (size_t y = 0; y < height; ++y) {
+        const uint8_t* row = &pixels[y * width * 4];
+        raw.push_back(1);
+        for (size_t i = 0; i < width * 4; ++i)
+            raw.push_back(static_cast<uint8_t>(row[i] - (i >= 4 ? row[i - 4] : 0)));
+    }
+
+    uLongf compressedSize = compressBound(static_cast<uLong>(raw.size()));
+    std::vector<uint8_t> idat(compressedSize);
+    compress2(idat.data(), &compressedSize, raw.data(), static_cast<uLong>(raw.size()), Z_DEFAULT_COMPRESSION);
+    idat.resize(compressedSize);
+
+    std::vector<uint8_t> ihdr = { static_cast<uint8_t>(width >> 24), static_cast<uint8_t>(width >> 16),
+        static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width), static_cast<uint8_t>(height >> 24),
+        static_cast<uint8_t>(height >> 16), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+        8, 6, 0, 0, 0 };
+
+    std::string png("\x89PNG\r\n\x1a\n", 8);
+    appendChunk(png, "IHDR", ihdr);
+    appendChunk(png, "IDAT", idat);
+    appendChunk(png, "IEND", {});
+    return png;
+}
+
+// Near-duplicate screenshots as the listener captures them (it asks for image/png first)
+Trace pngScreenshotTrace(std::mt19937& rng) {
+    Screen screen(rng);
+    Trace trace;
+    for (int k = 0; k < 20; ++k) {
+        screen.typeLine(k);
+        trace.push_back({ IMAGE, encodePng(screen.pixels(), Screen::Width, Screen::Height) });
+    }
+    return trace;
+}
+
+// The same screenshots as uncompressed 32-bit bitmaps. The listener only stores these when the
+// clipboard owner offers image/bmp but not image/png, so they are kept out of the mixed trace.
+Trace bmpScreenshotTrace(std::mt19937& rng) {
+    const size_t header = 54;
+    Screen screen(rng);
+    Trace trace;
+    for (int k = 0; k < 20; ++k) {
+        screen.typeLine(k);
+        std::string bmp(header, '\0');
+        bmp.append(screen.pixels().begin(), screen.pixels().end());
+        trace.push_back({ IMAGE, bmp });
+    }
+    return trace;
+}
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool run(const char* name, const Trace& trace) {
+    size_t total = 0;
+    for (const Capture& capture : trace)
+        total += capture.data.size();
+
+    PayloadStore store(0);
+    auto start = Clock::now();
+    uint64_t id = 0;
+    for (const Capture& capture : trace)
+        store.put(++id, capture.type, capture.data.data(), capture.data.size());
+    store.flush();
+    double packMs = millisecondsSince(start);
+
+    start = Clock::now();
+    int mismatches = 0;
+    std::vector<uint8_t> out;
+    int type;
+    for (uint64_t i = 1; i <= id; ++i) {
+        const Capture& capture = trace[i - 1];
+        if (!store.fetch(i, out, type) || type != capture.type ||
+            out.size() != capture.data.size() || !std::equal(out.begin(), out.end(), capture.data.begin(),
+                [](uint8_t a, char b) { return a == static_cast<uint8_t>(b); }))
+            ++mismatches;
+    }
+    double fetchMs = millisecondsSince(start);
+
+    start = Clock::now();
+    size_t lzOnly = 0;
+    for (const Capture& capture : trace)
+        lzOnly += LZ77::compress(reinterpret_cast<const uint8_t*>(capture.data.data()), capture.data.size()).size();
+    double lzMs = millisecondsSince(start);
+
+    PayloadStore::Stats stats = store.stats();
+    std::printf("%-18s %4zu entries (%3zu deltas) %9zu -> %8zu bytes  %6.2fx  pack %7.1f ms (%6.1f MB/s)  fetch %6.1f ms | LZ77 only %6.2fx  %6.1f ms\n",
+        name, stats.entries, stats.deltaEntries, stats.payloadBytes, stats.storedBytes,
+        static_cast<double>(stats.payloadBytes) / stats.storedBytes, packMs, total / packMs / 1000, fetchMs,
+        static_cast<double>(total) / lzOnly, lzMs);
+
+    if (mismatches != 0)
+        std::printf("%-18s %d payloads did not round-trip\n", name, mismatches);
+
+    return mismatches == 0;
+}
+
+// Short snippets of mixed-case text, with a file list every so often, as copied over a long session
+Trace searchHistoryTrace(std::mt19937& rng, size_t count) {
+    const char* words[] = { "The", "customer", "Reported", "that", "invoice", "number", "was", "MISSING", "from",
+        "account", "refund", "Ticket", "escalated", "to", "billing", "quarterly", "Report", "draft", "meeting",
+        "notes", "TODO", "fix", "login", "page", "build", "failed", "on", "main", "deploy", "staging" };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    Trace trace;
+    trace.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (rng() % 10 == 0) {
+            trace.push_back({ FILES, "file:///home/user/" + std::string(words[rng() % wordCount]) + "/doc" +
+                std::to_string(rng() % 5000) + ".txt\r\n" });
+            continue;
+        }
+
+        std::string text;
+        size_t length = 3 + rng() % 30;
+        for (size_t j = 0; j < length; ++j) {
+            text += words[rng() % wordCount];
+            text += ' ';
+        }
+        text += "INV-" + std::to_string(rng() % 100000);
+        trace.push_back({ TEXT, text });
+    }
+    return trace;
+}
+
+std::string foldCase(std::string text) {
+    for (char& c : text) {
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+    }
+    return text;
+}
+
+// What the index must return: every stored entry matching the query, newest first
+std::vector<uint64_t> linearSearch(const PayloadStore& store, uint64_t lastId, const std::string& query,
+    bool prefixOnly, size_t maxResults) {
+    std::string folded = foldCase(query);
+    std::vector<uint64_t> results;
+    std::vector<uint8_t> out;
+    int type;
+    for (uint64_t id = lastId; id >= 1 && results.size() < maxResults; --id) {
+        if (!store.fetch(id, out, type))
+            continue;
+
+        std::string text = foldCase(std::string(out.begin(), out.end()));
+        if (prefixOnly ? text.compare(0, folded.size(), folded) == 0 : text.find(folded) != std::string::npos)
+            results.push_back(id);
+    }
+    return results;
+}
+
+bool runSearch(size_t entries) {
+    std::mt19937 rng(11);
+    Trace trace = searchHistoryTrace(rng, entries);
+
+    PayloadStore store(0);
+    SearchIndex index([&store](uint64_t id, std::string& text) {
+        std::vector<uint8_t> out;
+        int type;
+        if (!store.fetch(id, out, type))
+            return false;
+        text.assign(out.begin(), out.end());
+        return true;
+    });
+
+    auto start = Clock::now();
+    uint64_t id = 0;
+    for (const Capture& capture : trace) {
+        store.put(++id, capture.type, capture.data.data(), capture.data.size());
+        index.add(id, capture.data);
+    }
+    double buildMs = millisecondsSince(start);
+    store.flush();
+
+    std::printf("\nsearch over %zu entries: indexed in %.1f ms, index holds %zu bytes\n",
+        entries, buildMs, index.memoryBytes());
+
+    struct Query {
+        const char* text;
+        bool prefixOnly;
+    };
+    const Query queries[] = {
+        { "invoice", false }, { "Escalated to BILLING", false }, { "inv-4242", false }, { "doc123.txt", false },
+        { "missing from account", false }, { "zzqx", false }, { "fi", false },
+        { "the customer", true }, { "file:///home/user/todo", true }, { "Build failed", true },
+        { "staging deploy", true }, { "x", true }
+    };
+
+    bool ok = true;
+    for (const Query& query : queries) {
+        for (size_t maxResults : { static_cast<size_t>(100), SIZE_MAX }) {
+            start = Clock::now();
+            std::vector<uint64_t> found = index.search(query.text, query.prefixOnly, maxResults);
+            double indexMs = millisecondsSince(start);
+
+            start = Clock::now();
+            std::vector<uint64_t> expected = linearSearch(store, id, query.text, query.prefixOnly, maxResults);
+            double scanMs = millisecondsSince(start);
+
+            bool match = found == expected;
+            ok &= match;
+            std::printf("%-6s %-26s max %-6s %6zu hits  index %8.2f ms  linear scan %8.2f ms%s\n",
+                query.prefixOnly ? "prefix" : "substr", ("\"" + std::string(query.text) + "\"").c_str(),
+                maxResults == SIZE_MAX ? "all" : "100", found.size(), indexMs, scanMs,
+                match ? "" : "  MISMATCH");
+        }
+    }
+    return ok;
+}
+
+int main() {
+    std::mt19937 rng(7);
+    Trace documents = editedDocumentTrace(rng);
+    Trace pngScreenshots = pngScreenshotTrace(rng);
+    Trace bmpScreenshots = bmpScreenshotTrace(rng);
+
+    Trace mixed;
+    for (const Trace* trace : { &documents, &pngScreenshots })
+        mixed.insert(mixed.end(), trace->begin(), trace->end());
+
+    bool ok = true;
+    ok &= run("edited text", documents);
+    ok &= run("png screenshots", pngScreenshots);
+    ok &= run("mixed", mixed);
+    ok &= run("bmp (not captured)", bmpScreenshots);
+    ok &= runSearch(100000);
+    return ok ? 0 : 1;
+}
@@ -10,13 +10,34 @@
 #include <iomanip>
 #include <sstream>
 #include <atomic>
+#include <algorithm>
 #include "ClipboardMonitor.h"
 #include "sha256.h"
+#include "SearchIndex.h"
+#include "PayloadStore.h"
 
 // Global variables for storing callbacks
 ClipboardChangedCallback g_clipboardCallback = nullptr;
 ClipboardChangedCallbackWithData g_callback = nullptr;
 
+// Id of the last clipboard entry captured (0 if none). Shared by the search index and payload store.
+std::atomic<unsigned long long> g_lastEntryId(0);
+
+// Compressed storage of captured payloads. Its capacity is the capacity of the whole history.
+PayloadStore g_payloadStore;
+
+// Search index over text and files clipboard history, aged out with the payload store.
+// It keeps no text itself; matches are confirmed against the stored payloads.
+SearchIndex g_searchIndex([](uint64_t id, std::string& text) {
+    std::vector<uint8_t> payload;
+    int type;
+    if (!g_payloadStore.fetch(id, payload, type))
+        return false;
+
+    text.assign(payload.begin(), payload.end());
+    return true;
+});
+
 class ClipboardListener {
 public:
     ClipboardListener() : running_(true) {}
@@ -93,6 +114,15 @@ public:
             if (dataType != NONE && !currentGlobalHash.empty() && currentGlobalHash != lastGlobalHash) {
                 lastGlobalHash = currentGlobalHash;
 
+                // --- Store and index before notifying so the entry id is available to callbacks ---
+                unsigned long long entryId = ++g_lastEntryId;
+                g_payloadStore.put(entryId, dataType, content.data(), dataSize);
+
+                if (dataType == TEXT || dataType == FILES) {
+                    g_searchIndex.add(entryId, content);
+                }
+                g_searchIndex.evictBefore(g_payloadStore.firstId());
+
                 // --- Trigger callback only once per logical copy ---
                 if (g_clipboardCallback != nullptr) {
                     g_clipboardCallback();
@@ -215,6 +245,75 @@ extern "C" __attribute__((visibility("default"))) void SetClipboardChangedCallba
     g_callback = callback;
 }
 
+// Search clipboard history for entries containing (or starting with, if prefixOnly is non-zero) the query.
+// Writes up to maxResults entry ids to outIds, newest first, and returns the number written.
+extern "C" __attribute__((visibility("default"))) size_t SearchClipboardHistory(const char* query, int prefixOnly, unsigned long long* outIds, size_t maxResults) {
+    if (!query || !outIds)
+        return 0;
+
+    std::vector<uint64_t> ids = g_searchIndex.search(query, prefixOnly != 0, maxResults);
+    std::copy(ids.begin(), ids.end(), outIds);
+    return ids.size();
+}
+
+// Get the id of the most recently captured clipboard entry (0 if none)
+extern "C" __attribute__((visibility("default"))) unsigned long long GetLastClipboardEntryId() {
+    return g_lastEntryId;
+}
+
+// Get a stored clipboard payload by entry id. Returns the payload size and sets type (0 and NONE if not stored).
+// The payload is only unpacked and copied if bufferSize is large enough, so call with a null buffer first to get
+// the size cheaply.
+extern "C" __attribute__((visibility("default"))) size_t GetClipboardPayload(unsigned long long id, char* buffer, size_t bufferSize, int* type) {
+    size_t payloadSize = 0;
+    int payloadType = NONE;
+    bool stored = g_payloadStore.size(id, payloadSize, payloadType);
+
+    if (stored && buffer && bufferSize >= payloadSize) {
+        std::vector<uint8_t> payload;
+        if (g_payloadStore.fetch(id, payload, payloadType) && payload.size() <= bufferSize) {
+            std::copy(payload.begin(), payload.end(), buffer);
+            payloadSize = payload.size();
+        }
+        else {
+            // Evicted (or unreadable) since the size lookup
+            payloadSize = 0;
+            payloadType = NONE;
+        }
+    }
+
+    if (type)
+        *type = payloadType;
+
+    return payloadSize;
+}
+
+// Get the total size of stored payloads as captured, and the memory actually held for the history
+// (packed payloads plus the search index's posting lists)
+extern "C" __attribute__((visibility("default"))) void GetClipboardStorageStats(size_t* payloadBytes, size_t* storedBytes) {
+    PayloadStore::Stats stats = g_payloadStore.stats();
+    if (payloadBytes)
+        *payloadBytes = stats.payloadBytes;
+    if (storedBytes)
+        *storedBytes = stats.storedBytes + g_searchIndex.memoryBytes();
+}
+
+// Set the maximum number of clipboard entries kept (0 = unlimited, default 10000). Oldest entries are evicted first.
+// This applies to payload storage and the search index together: every entry, images included, counts towards it,
+// and an entry leaves the search index when its payload is evicted, so every search hit can be fetched.
+// With the default, search never covers more than the last 10000 entries (fewer when images are copied);
+// callers that want to search a longer history, e.g. 100k entries, have to raise the capacity.
+extern "C" __attribute__((visibility("default"))) void SetClipboardHistoryCapacity(size_t capacity) {
+    g_payloadStore.setCapacity(capacity);
+    g_searchIndex.evictBefore(g_payloadStore.firstId());
+}
+
+// Remove all entries from the search index and payload storage
+extern "C" __attribute__((visibility("default"))) void ClearClipboardHistory() {
+    g_searchIndex.clear();
+    g_payloadStore.clear();
+}
+
 // Expose a function to stop the listener (just to clean up later if needed)
 extern "C" __attribute__((visibility("default"))) void StopClipboardListener() {
     // You could add a mechanism here to cleanly stop the listener if needed
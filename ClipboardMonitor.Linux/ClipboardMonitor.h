@@ -24,6 +24,19 @@ extern "C" {
     void SetClipboardChangedCallback(ClipboardChangedCallback callback);
     void SetClipboardChangedCallbackWithData(ClipboardChangedCallbackWithData callback);
 
+    // Clipboard history (capacity covers payload storage and the search index together; the default of
+    // 10000 entries, images included, also bounds how far back search reaches)
+    unsigned long long GetLastClipboardEntryId();
+    void SetClipboardHistoryCapacity(size_t capacity);
+    void ClearClipboardHistory();
+
+    // Clipboard history search (text and files entries)
+    size_t SearchClipboardHistory(const char* query, int prefixOnly, unsigned long long* outIds, size_t maxResults);
+
+    // Clipboard payload storage (all entry types)
+    size_t GetClipboardPayload(unsigned long long id, char* buffer, size_t bufferSize, int* type);
+    void GetClipboardStorageStats(size_t* payloadBytes, size_t* storedBytes);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
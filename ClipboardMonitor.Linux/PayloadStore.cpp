@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include "PayloadStore.h"
+#include "lz77.h"
+
+namespace {
+    // Payloads smaller than this are only compressed; a delta would not pay for itself
+    const size_t MinDeltaSize = 512;
+
+    // Content-defined chunk bounds (average chunk is roughly ChunkMask + 1 bytes)
+    const size_t MinChunk = 64;
+    const size_t MaxChunk = 8192;
+    const uint64_t ChunkMask = 0x1FF;
+
+    struct Chunk {
+        size_t offset;
+        size_t length;
+    };
+
+    const uint64_t* gearTable() {
+        static const struct Table {
+            uint64_t values[256];
+            Table() {
+                // splitmix64, so the table is fixed without shipping 256 constants
+                uint64_t state = 0x9E3779B97F4A7C15ull;
+                for (uint64_t& value : values) {
+                    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+                    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                    value = z ^ (z >> 31);
+                }
+            }
+        } table;
+        return table.values;
+    }
+
+    // Split data at positions chosen by a gear rolling hash, so boundaries follow the content
+    std::vector<Chunk> chunk(const uint8_t* data, size_t len) {
+        const uint64_t* gear = gearTable();
+        std::vector<Chunk> chunks;
+        size_t start = 0;
+        uint64_t h = 0;
+
+        for (size_t i = 0; i < len; ++i) {
+            h = (h << 1) + gear[data[i]];
+            size_t length = i + 1 - start;
+            if ((length >= MinChunk && (h & ChunkMask) == 0) || length >= MaxChunk) {
+                chunks.push_back({ start, length });
+                start = i + 1;
+                h = 0;
+            }
+        }
+
+        if (start < len)
+            chunks.push_back({ start, len - start });
+
+        return chunks;
+    }
+
+    uint64_t chunkHash(const uint8_t* data, size_t len) {
+        uint64_t h = 0xCBF29CE484222325ull; // FNV-1a
+        for (size_t i = 0; i < len; ++i) {
+            h ^= data[i];
+            h *= 0x100000001B3ull;
+        }
+        return h;
+    }
+
+    // Delta format: sequence of varint (length << 1 | isCopy), followed by either
+    // a varint offset into the base (copy) or the literal bytes.
+    void writeOp(std::vector<uint8_t>& out, const std::vector<uint8_t>& target, bool copy, size_t offset, size_t length) {
+        LZ77::writeVarint(out, (static_cast<uint64_t>(length) << 1) | (copy ? 1 : 0));
+        if (copy)
+            LZ77::writeVarint(out, offset);
+        else
+            out.insert(out.end(), target.begin() + offset, target.begin() + offset + length);
+    }
+
+    // Encode target against base. Returns false if less than half of target is shared with base.
+    bool makeDelta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target, std::vector<uint8_t>& out) {
+        std::unordered_multimap<uint64_t, Chunk> baseChunks;
+        for (const Chunk& c : chunk(base.data(), base.size()))
+            baseChunks.emplace(chunkHash(base.data() + c.offset, c.length), c);
+
+        size_t matched = 0;
+        size_t literalStart = 0;
+        bool copying = false;
+        size_t copyOffset = 0, copyLength = 0;
+
+        out.clear();
+        for (const Chunk& c : chunk(target.data(), target.size())) {
+            const Chunk* hit = nullptr;
+            auto range = baseChunks.equal_range(chunkHash(target.data() + c.offset, c.length));
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second.length == c.length &&
+                    std::memcmp(base.data() + it->second.offset, target.data() + c.offset, c.length) == 0) {
+                    hit = &it->second;
+                    break;
+                }
+            }
+
+            if (!hit) {
+                if (copying) {
+                    writeOp(out, target, true, copyOffset, copyLength);
+                    copying = false;
+                    literalStart = c.offset;
+                }
+                continue;
+            }
+
+            matched += c.length;
+
+            // Extend the current copy when the base chunks are contiguous too
+            if (copying && copyOffset + copyLength == hit->offset) {
+                copyLength += c.length;
+                continue;
+            }
+
+            if (copying)
+                writeOp(out, target, true, copyOffset, copyLength);
+            else if (c.offset > literalStart)
+                writeOp(out, target, false, literalStart, c.offset - literalStart);
+
+            copying = true;
+            copyOffset = hit->offset;
+            copyLength = c.length;
+        }
+
+        if (copying)
+            writeOp(out, target, true, copyOffset, copyLength);
+        else if (target.size() > literalStart)
+            writeOp(out, target, false, literalStart, target.size() - literalStart);
+
+        return matched * 2 >= target.size();
+    }
+
+    bool applyDelta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& delta, size_t size, std::vector<uint8_t>& out) {
+        out.clear();
+        out.reserve(size);
+
+        size_t pos = 0;
+        while (pos < delta.size()) {
+            uint64_t op, offset;
+            if (!LZ77::readVarint(delta.data(), delta.size(), pos, op))
+                return false;
+
+            uint64_t length = op >> 1;
+            if (length > size - out.size())
+                return false;
+
+            if (op & 1) {
+                if (!LZ77::readVarint(delta.data(), delta.size(), pos, offset) || offset > base.size() || length > base.size() - offset)
+                    return false;
+                out.insert(out.end(), base.begin() + offset, base.begin() + offset + length);
+            }
+            else {
+                if (length > delta.size() - pos)
+                    return false;
+                out.insert(out.end(), delta.begin() + pos, delta.begin() + pos + length);
+                pos += length;
+            }
+        }
+
+        return out.size() == size;
+    }
+}
+
+PayloadStore::PayloadStore(size_t capacity) : capacity_(capacity) {}
+
+PayloadStore::~PayloadStore() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    if (worker_.joinable())
+        worker_.join();
+}
+
+void PayloadStore::put(uint64_t id, int type, const char* data, size_t size) {
+    // Copy the payload before taking the lock
+    Link raw = { Encoding::Raw, std::make_shared<const std::vector<uint8_t>>(data, data + size), size };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id <= lastId_)
+        return;
+
+    lastId_ = id;
+    entries_.push_back({ id, type, std::move(raw), 0, 0, true, true, {} });
+    ++stats_.entries;
+    stats_.payloadBytes += size;
+    stats_.storedBytes += size;
+
+    while (capacity_ != 0 && entries_.size() > capacity_)
+        evictOldest();
+
+    // Started on first use so loading the library alone doesn't spawn a thread
+    if (!worker_.joinable())
+        worker_ = std::thread(&PayloadStore::worker, this);
+
+    enqueue(id);
+}
+
+bool PayloadStore::fetch(uint64_t id, std::vector<uint8_t>& out, int& type) const {
+    Chain chain;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Entry* entry = find(id);
+        if (!entry || !snapshot(*entry, chain))
+            return false;
+
+        type = entry->type;
+    }
+
+    return unpack(chain, out);
+}
+
+bool PayloadStore::size(uint64_t id, size_t& size, int& type) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Entry* entry = find(id);
+    if (!entry)
+        return false;
+
+    size = entry->packed.size;
+    type = entry->type;
+    return true;
+}
+
+void PayloadStore::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+
+    while (capacity_ != 0 && entries_.size() > capacity_)
+        evictOldest();
+}
+
+uint64_t PayloadStore::firstId() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.empty() ? lastId_ + 1 : entries_.front().id;
+}
+
+void PayloadStore::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    pending_.clear();
+    stats_ = Stats();
+}
+
+void PayloadStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return (pending_.empty() && !packing_) || !worker_.joinable(); });
+}
+
+PayloadStore::Stats PayloadStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool PayloadStore::unpack(const Chain& chain, std::vector<uint8_t>& out) {
+    if (chain.empty())
+        return false;
+
+    // Unpack the full payload at the end, then apply the deltas back up to the entry
+    const Link& full = chain.back();
+    if (full.encoding == Encoding::Raw)
+        out = *full.data;
+    else if (full.encoding != Encoding::Compressed || !LZ77::decompress(*full.data, out) || out.size() != full.size)
+        return false;
+
+    std::vector<uint8_t> delta;
+    std::vector<uint8_t> next;
+    for (size_t i = chain.size() - 1; i-- > 0;) {
+        if (!LZ77::decompress(*chain[i].data, delta) || !applyDelta(out, delta, chain[i].size, next))
+            return false;
+        out.swap(next);
+    }
+
+    return true;
+}
+
+size_t PayloadStore::heldBytes(const Entry& entry) {
+    size_t bytes = entry.packed.data->size();
+    for (const Link& link : entry.evictedBases)
+        bytes += link.data->size();
+    return bytes;
+}
+
+bool PayloadStore::snapshot(const Entry& entry, Chain& chain) const {
+    chain.clear();
+
+    const Entry* current = &entry;
+    while (true) {
+        chain.push_back(current->packed);
+        if (current->packed.encoding != Encoding::Delta)
+            return true;
+
+        if (!current->evictedBases.empty()) {
+            chain.insert(chain.end(), current->evictedBases.begin(), current->evictedBases.end());
+            return true;
+        }
+
+        current = find(current->baseId);
+        if (!current)
+            return false;
+    }
+}
+
+size_t PayloadStore::indexOf(uint64_t id) const {
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), id,
+        [](const Entry& entry, uint64_t value) { return entry.id < value; });
+
+    return (it != entries_.end() && it->id == id) ? static_cast<size_t>(it - entries_.begin()) : entries_.size();
+}
+
+PayloadStore::Entry* PayloadStore::find(uint64_t id) {
+    size_t index = indexOf(id);
+    return index < entries_.size() ? &entries_[index] : nullptr;
+}
+
+const PayloadStore::Entry* PayloadStore::find(uint64_t id) const {
+    size_t index = indexOf(id);
+    return index < entries_.size() ? &entries_[index] : nullptr;
+}
+
+void PayloadStore::evictOldest() {
+    Entry& oldest = entries_.front();
+    bool handedOver = false;
+
+    // Only the next entry of the same type can be a delta against this one. Hand it the packed base
+    // chain so it stays readable, and let the worker re-pack it as a full payload.
+    for (size_t i = 1; i < entries_.size(); ++i) {
+        Entry& next = entries_[i];
+        if (next.type != oldest.type)
+            continue;
+
+        if (next.packed.encoding == Encoding::Delta && next.baseId == oldest.id) {
+            snapshot(oldest, next.evictedBases);
+            next.allowDelta = false;
+            handedOver = true;
+            if (!next.pending) {
+                next.pending = true;
+                enqueue(next.id);
+            }
+        }
+        break;
+    }
+
+    --stats_.entries;
+    stats_.payloadBytes -= oldest.packed.size;
+    if (!handedOver)
+        stats_.storedBytes -= heldBytes(oldest);
+    if (oldest.packed.encoding == Encoding::Delta)
+        --stats_.deltaEntries;
+
+    entries_.pop_front();
+}
+
+void PayloadStore::enqueue(uint64_t id) {
+    pending_.push_back(id);
+    wake_.notify_one();
+}
+
+void PayloadStore::worker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (stopping_)
+            break;
+
+        uint64_t id = pending_.front();
+        pending_.pop_front();
+
+        size_t index = indexOf(id);
+        Chain current;
+        if (index == entries_.size() || !entries_[index].pending || !snapshot(entries_[index], current)) {
+            if (pending_.empty())
+                idle_.notify_all();
+            continue;
+        }
+
+        // The delta base is the previous entry of the same type, if its chain isn't already too long
+        const Entry& entry = entries_[index];
+        Chain base;
+        uint64_t baseId = 0;
+        int baseDepth = 0;
+        if (entry.allowDelta && entry.packed.size >= MinDeltaSize) {
+            for (size_t i = index; i-- > 0;) {
+                const Entry& previous = entries_[i];
+                if (previous.type != entry.type)
+                    continue;
+                if (previous.depth < MaxDeltaDepth && snapshot(previous, base)) {
+                    baseId = previous.id;
+                    baseDepth = previous.depth;
+                }
+                break;
+            }
+        }
+
+        packing_ = true;
+        lock.unlock();
+
+        // Unpack and pack without the lock
+        std::vector<uint8_t> payload;
+        std::vector<uint8_t> basePayload;
+        std::vector<uint8_t> delta;
+        Link packed = { Encoding::Raw, nullptr, 0 };
+
+        if (unpack(current, payload)) {
+            packed.size = payload.size();
+            if (baseId != 0 && unpack(base, basePayload) && makeDelta(basePayload, payload, delta)) {
+                packed.encoding = Encoding::Delta;
+                packed.data = std::make_shared<const std::vector<uint8_t>>(LZ77::compress(delta));
+            }
+            else {
+                std::vector<uint8_t> compressed = LZ77::compress(payload);
+                if (compressed.size() < payload.size()) {
+                    packed.encoding = Encoding::Compressed;
+                    packed.data = std::make_shared<const std::vector<uint8_t>>(std::move(compressed));
+                }
+                else if (current.front().encoding != Encoding::Raw) {
+                    packed.data = std::make_shared<const std::vector<uint8_t>>(std::move(payload));
+                }
+            }
+        }
+
+        // Drop the unpacked copies before waiting on the lock again
+        payload = std::vector<uint8_t>();
+        basePayload = std::vector<uint8_t>();
+        current.clear();
+        base.clear();
+
+        lock.lock();
+        packing_ = false;
+
+        Entry* target = find(id);
+        if (target) {
+            if (packed.encoding == Encoding::Delta && !find(baseId)) {
+                // Base was evicted while packing; try again as a full payload
+                target->allowDelta = false;
+                pending_.push_front(id);
+                continue;
+            }
+
+            target->pending = false;
+            if (packed.data) {
+                stats_.storedBytes -= heldBytes(*target);
+                stats_.storedBytes += packed.data->size();
+                if (target->packed.encoding == Encoding::Delta)
+                    --stats_.deltaEntries;
+                if (packed.encoding == Encoding::Delta)
+                    ++stats_.deltaEntries;
+
+                target->packed = std::move(packed);
+                target->baseId = target->packed.encoding == Encoding::Delta ? baseId : 0;
+                target->depth = target->packed.encoding == Encoding::Delta ? baseDepth + 1 : 0;
+                target->evictedBases.clear();
+            }
+        }
+
+        if (pending_.empty())
+            idle_.notify_all();
+    }
+
+    idle_.notify_all();
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Storage for captured clipboard payloads, keyed by entry id.
+// Payloads are stored raw on capture and packed on a background thread, either LZ77 compressed or,
+// when nearly identical to the previous entry of the same type, as a compressed delta against it.
+// Near-duplicates are found by content-defined chunking (gear rolling hash), so an insertion or
+// edit only disturbs the chunks around it. Payloads are unpacked on fetch, outside the lock, so a
+// large fetch doesn't hold up capture or packing.
+
+class PayloadStore {
+public:
+    static const size_t DefaultCapacity = 10000;
+
+    struct Stats {
+        size_t entries = 0;
+        size_t deltaEntries = 0;
+        size_t payloadBytes = 0; // total size of payloads as captured
+        size_t storedBytes = 0;  // total size held in memory by the store
+    };
+
+    explicit PayloadStore(size_t capacity = DefaultCapacity);
+    ~PayloadStore();
+
+    // Store a payload, evicting the oldest entries if over capacity.
+    // Ids not greater than the last one stored are ignored.
+    void put(uint64_t id, int type, const char* data, size_t size);
+
+    // Unpack a stored payload. Returns false if the entry is not (or no longer) stored.
+    bool fetch(uint64_t id, std::vector<uint8_t>& out, int& type) const;
+
+    // Look up the unpacked size and type of a stored payload without unpacking it.
+    // Returns false if the entry is not (or no longer) stored.
+    bool size(uint64_t id, size_t& size, int& type) const;
+
+    // Set the maximum number of entries kept (0 = unlimited).
+    void setCapacity(size_t capacity);
+
+    // Id of the oldest entry still stored (one past the last id if empty).
+    uint64_t firstId() const;
+
+    // Remove all entries.
+    void clear();
+
+    // Block until all pending payloads have been packed.
+    void flush();
+
+    Stats stats() const;
+
+private:
+    enum class Encoding { Raw, Compressed, Delta };
+
+    // One packed payload. The data is replaced, never modified, so it can be unpacked without the lock.
+    struct Link {
+        Encoding encoding;
+        std::shared_ptr<const std::vector<uint8_t>> data;
+        size_t size; // unpacked size
+    };
+
+    // An entry's packed payload followed by each base its delta needs, down to a full payload
+    using Chain = std::vector<Link>;
+
+    struct Entry {
+        uint64_t id;
+        int type;
+        Link packed;
+        uint64_t baseId;                 // entry the delta applies to (Delta only)
+        int depth;                       // length of the delta chain to a full payload
+        bool pending;                    // queued for the worker to pack
+        bool allowDelta;                 // false when re-packing an entry whose base was evicted
+        std::vector<Link> evictedBases;  // evicted base chain still needed by this entry's delta
+    };
+
+    static const int MaxDeltaDepth = 8;
+
+    static bool unpack(const Chain& chain, std::vector<uint8_t>& out);
+    static size_t heldBytes(const Entry& entry);
+
+    bool snapshot(const Entry& entry, Chain& chain) const;
+    size_t indexOf(uint64_t id) const;
+    Entry* find(uint64_t id);
+    const Entry* find(uint64_t id) const;
+    void evictOldest();
+    void enqueue(uint64_t id);
+    void worker();
+
+    std::deque<Entry> entries_; // in id order
+    uint64_t lastId_ = 0;
+    size_t capacity_;
+    Stats stats_;
+    mutable std::mutex mutex_;
+
+    // Background packing
+    std::deque<uint64_t> pending_;
+    bool packing_ = false;
+    bool stopping_ = false;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::thread worker_;
+};
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include "SearchIndex.h"
+
+namespace {
+    // Evicted ids are dropped from posting lists in batches once this many have aged out
+    const size_t MinCompactBatch = 1024;
+
+    uint32_t trigramKey(const std::string& text, size_t pos) {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16) |
+            (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8) |
+            static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+    }
+
+    // Key for the first two bytes of the text. Bit 24 keeps it apart from every trigram key.
+    uint32_t prefixKey(const std::string& text) {
+        return (1u << 24) |
+            (static_cast<uint32_t>(static_cast<unsigned char>(text[0])) << 8) |
+            static_cast<uint32_t>(static_cast<unsigned char>(text[1]));
+    }
+
+    // Distinct trigrams of already folded text, sorted
+    std::vector<uint32_t> trigrams(const std::string& text) {
+        std::vector<uint32_t> keys;
+        if (text.size() < 3)
+            return keys;
+
+        keys.reserve(text.size() - 2);
+        for (size_t i = 0; i + 2 < text.size(); ++i)
+            keys.push_back(trigramKey(text, i));
+
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        return keys;
+    }
+
+    // Keep only the ids in 'ids' that are also in the (sorted) decoded list
+    void intersect(std::vector<uint64_t>& ids, const std::vector<uint64_t>& other) {
+        auto out = ids.begin();
+        auto it = other.begin();
+        for (uint64_t id : ids) {
+            while (it != other.end() && *it < id)
+                ++it;
+            if (it == other.end())
+                break;
+            if (*it == id)
+                *out++ = id;
+        }
+        ids.erase(out, ids.end());
+    }
+}
+
+SearchIndex::SearchIndex(TextSource source) : source_(std::move(source)) {}
+
+void SearchIndex::add(uint64_t id, const std::string& text) {
+    std::string folded = fold(text);
+    std::vector<uint32_t> keys = trigrams(folded);
+    if (folded.size() >= 2)
+        keys.push_back(prefixKey(folded));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id <= lastId_)
+        return;
+
+    lastId_ = id;
+    for (uint32_t key : keys)
+        append(postings_[key], id);
+
+    ids_.push_back(id);
+}
+
+std::vector<uint64_t> SearchIndex::search(const std::string& query, bool prefixOnly, size_t maxResults) const {
+    std::vector<uint64_t> results;
+    if (query.empty() || maxResults == 0)
+        return results;
+
+    std::string folded = fold(query);
+    std::vector<uint32_t> keys = trigrams(folded);
+    if (prefixOnly && folded.size() >= 2)
+        keys.push_back(prefixKey(folded));
+
+    std::vector<uint64_t> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (keys.empty()) {
+            // Too short for the index - every live entry is a candidate
+            candidates.assign(ids_.begin(), ids_.end());
+        }
+        else {
+            // Intersect posting lists, starting from the shortest
+            std::vector<const PostingList*> lists;
+            lists.reserve(keys.size());
+            for (uint32_t key : keys) {
+                auto it = postings_.find(key);
+                if (it == postings_.end())
+                    return results;
+                lists.push_back(&it->second);
+            }
+
+            std::sort(lists.begin(), lists.end(),
+                [](const PostingList* a, const PostingList* b) { return a->count < b->count; });
+
+            std::vector<uint64_t> decoded;
+            decode(*lists[0], firstId_, candidates);
+            for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+                decoded.clear();
+                decode(*lists[i], firstId_, decoded);
+                intersect(candidates, decoded);
+            }
+        }
+    }
+
+    // The index only narrows the set down; confirm the actual match against the stored text, newest first.
+    // Entries evicted since the lock was released simply fail to read back.
+    std::string text;
+    for (auto it = candidates.rbegin(); it != candidates.rend() && results.size() < maxResults; ++it) {
+        if (source_(*it, text) && matches(fold(std::move(text)), folded, prefixOnly))
+            results.push_back(*it);
+    }
+
+    return results;
+}
+
+void SearchIndex::evictBefore(uint64_t firstId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    while (!ids_.empty() && ids_.front() < firstId)
+        evictOldest();
+}
+
+void SearchIndex::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ids_.clear();
+    postings_.clear();
+    firstId_ = lastId_ + 1;
+    evictedSinceCompact_ = 0;
+}
+
+size_t SearchIndex::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t bytes = ids_.size() * sizeof(uint64_t);
+    for (const auto& posting : postings_)
+        bytes += sizeof(posting) + posting.second.deltas.capacity();
+    return bytes;
+}
+
+std::string SearchIndex::fold(std::string text) {
+    for (char& c : text) {
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+    }
+    return text;
+}
+
+void SearchIndex::appendVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void SearchIndex::decode(const PostingList& list, uint64_t minId, std::vector<uint64_t>& out) {
+    uint64_t id = 0;
+    size_t pos = 0;
+    while (pos < list.deltas.size()) {
+        uint64_t delta = 0;
+        int shift = 0;
+        uint8_t byte;
+        do {
+            byte = list.deltas[pos++];
+            delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        id += delta;
+        if (id >= minId)
+            out.push_back(id);
+    }
+}
+
+void SearchIndex::append(PostingList& list, uint64_t id) {
+    if (list.count == 0)
+        list.firstId = id;
+
+    appendVarint(list.deltas, id - list.lastId);
+    list.lastId = id;
+    ++list.count;
+}
+
+bool SearchIndex::matches(const std::string& text, const std::string& query, bool prefixOnly) {
+    if (prefixOnly)
+        return text.compare(0, query.size(), query) == 0;
+
+    return text.find(query) != std::string::npos;
+}
+
+void SearchIndex::evictOldest() {
+    ids_.pop_front();
+    firstId_ = ids_.empty() ? lastId_ + 1 : ids_.front();
+
+    // Stale ids are skipped by decode() until enough have built up to be worth rewriting the lists
+    if (++evictedSinceCompact_ >= std::max(MinCompactBatch, ids_.size() / 4))
+        compact();
+}
+
+void SearchIndex::compact() {
+    std::vector<uint64_t> live;
+    for (auto it = postings_.begin(); it != postings_.end();) {
+        PostingList& list = it->second;
+        if (list.firstId >= firstId_) {
+            ++it;
+            continue;
+        }
+
+        live.clear();
+        decode(list, firstId_, live);
+        if (live.empty()) {
+            it = postings_.erase(it);
+            continue;
+        }
+
+        PostingList rebuilt;
+        for (uint64_t id : live)
+            append(rebuilt, id);
+        rebuilt.deltas.shrink_to_fit();
+        list = std::move(rebuilt);
+        ++it;
+    }
+
+    evictedSinceCompact_ = 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Incremental trigram index over clipboard history (text and file entries).
+// Entries are keyed by the caller's entry id, which must increase with each add. The index has no
+// capacity of its own; the owner ages entries out with evictBefore(). Every distinct trigram maps to
+// a posting list of the ids containing it, stored as varint-encoded deltas. Because ids only ever
+// increase, new ids are appended to the end of a list and aged-out ids are always at the front of it.
+// Each entry also gets a start-of-text key (its first two bytes) so prefix queries are narrowed by
+// the index rather than only checked afterwards.
+// The index keeps no text of its own. Candidates are confirmed by reading the entry's text back
+// through the TextSource (the payload store), outside the index lock.
+// Matching is ASCII case-insensitive. Queries with no usable keys fall back to a linear scan.
+
+class SearchIndex {
+public:
+    // Reads back the text of an entry. Returns false if it is no longer stored.
+    using TextSource = std::function<bool(uint64_t id, std::string& text)>;
+
+    explicit SearchIndex(TextSource source);
+
+    // Add an entry to the index. Ids not greater than the last one added are ignored.
+    void add(uint64_t id, const std::string& text);
+
+    // Return ids of entries containing (or starting with, if prefixOnly) the query, newest first.
+    std::vector<uint64_t> search(const std::string& query, bool prefixOnly, size_t maxResults) const;
+
+    // Remove entries with ids below firstId.
+    void evictBefore(uint64_t firstId);
+
+    // Remove all entries.
+    void clear();
+
+    // Approximate memory held by the posting lists and id list.
+    size_t memoryBytes() const;
+
+private:
+    struct PostingList {
+        std::vector<uint8_t> deltas;
+        uint64_t firstId = 0;
+        uint64_t lastId = 0;
+        size_t count = 0;
+    };
+
+    static std::string fold(std::string text);
+    static void appendVarint(std::vector<uint8_t>& out, uint64_t value);
+    static void decode(const PostingList& list, uint64_t minId, std::vector<uint64_t>& out);
+    static void append(PostingList& list, uint64_t id);
+
+    static bool matches(const std::string& text, const std::string& query, bool prefixOnly);
+    void evictOldest();
+    void compact();
+
+    TextSource source_;
+
+    // Ids of live entries, in order
+    std::deque<uint64_t> ids_;
+    std::unordered_map<uint32_t, PostingList> postings_;
+    uint64_t firstId_ = 0; // ids below this have been evicted
+    uint64_t lastId_ = 0;
+    size_t evictedSinceCompact_ = 0;
+    mutable std::mutex mutex_;
+};
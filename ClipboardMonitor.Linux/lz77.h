@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Simple header-only LZ77 codec (LZ4-style greedy matching with a single-entry hash table)
+// Does not require zlib or any external library
+// Tuned for speed over ratio, so it can keep up with clipboard capture on a background thread
+//
+// Format: varint uncompressed size, then sequences of
+//   varint literal count, literal bytes, varint match offset, varint (match length - MinMatch)
+// The final sequence has literals only and ends at the end of the input.
+
+class LZ77 {
+public:
+    static std::vector<uint8_t> compress(const std::vector<uint8_t>& data) {
+        return compress(data.data(), data.size());
+    }
+
+    static std::vector<uint8_t> compress(const uint8_t* data, size_t len) {
+        std::vector<uint8_t> out;
+        out.reserve(len / 2 + 16);
+        writeVarint(out, len);
+
+        std::vector<uint32_t> table(HashSize, 0); // position + 1 of last occurrence, 0 = none
+        size_t anchor = 0;
+        size_t pos = 0;
+
+        while (len >= MinMatch && pos <= len - MinMatch) {
+            uint32_t h = hash(data + pos);
+            size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(pos + 1);
+
+            if (candidate == 0 || std::memcmp(data + candidate - 1, data + pos, MinMatch) != 0) {
+                ++pos;
+                continue;
+            }
+
+            size_t matchPos = candidate - 1;
+            size_t matchLen = MinMatch;
+            while (pos + matchLen < len && data[matchPos + matchLen] == data[pos + matchLen])
+                ++matchLen;
+
+            writeVarint(out, pos - anchor);
+            out.insert(out.end(), data + anchor, data + pos);
+            writeVarint(out, pos - matchPos);
+            writeVarint(out, matchLen - MinMatch);
+
+            // Seed the table inside long matches sparsely to keep this cheap
+            for (size_t i = pos + 1; i + MinMatch <= len && i < pos + matchLen; i += 4)
+                table[hash(data + i)] = static_cast<uint32_t>(i + 1);
+
+            pos += matchLen;
+            anchor = pos;
+        }
+
+        writeVarint(out, len - anchor);
+        out.insert(out.end(), data + anchor, data + len);
+        return out;
+    }
+
+    // Returns false if the input is truncated or corrupt
+    static bool decompress(const std::vector<uint8_t>& data, std::vector<uint8_t>& out) {
+        return decompress(data.data(), data.size(), out);
+    }
+
+    static bool decompress(const uint8_t* data, size_t len, std::vector<uint8_t>& out) {
+        size_t pos = 0;
+        uint64_t size;
+        if (!readVarint(data, len, pos, size))
+            return false;
+
+        out.clear();
+        out.reserve(size);
+
+        while (true) {
+            uint64_t literals;
+            if (!readVarint(data, len, pos, literals) || literals > len - pos || out.size() + literals > size)
+                return false;
+
+            out.insert(out.end(), data + pos, data + pos + literals);
+            pos += literals;
+
+            if (pos == len)
+                return out.size() == size;
+
+            uint64_t offset, matchLen;
+            if (!readVarint(data, len, pos, offset) || !readVarint(data, len, pos, matchLen) || matchLen > size)
+                return false;
+
+            matchLen += MinMatch;
+            if (offset == 0 || offset > out.size() || out.size() + matchLen > size)
+                return false;
+
+            // Byte-wise copy so overlapping matches (offset < length) repeat correctly
+            size_t from = out.size() - offset;
+            for (size_t i = 0; i < matchLen; ++i)
+                out.push_back(out[from + i]);
+        }
+    }
+
+    static void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static bool readVarint(const uint8_t* data, size_t len, size_t& pos, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= len)
+                return false;
+            uint8_t byte = data[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    static const size_t MinMatch = 4;
+    static const int HashBits = 16;
+    static const size_t HashSize = size_t(1) << HashBits;
+
+    static uint32_t hash(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return (v * 2654435761u) >> (32 - HashBits);
+    }
+};